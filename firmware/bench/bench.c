@@ -0,0 +1,88 @@
+/*
+ * Benchmark driver linked against the firmware objects instead of
+ * ascii_stick_zero3_reiwa.o, once per MCU role: bench.elf for the
+ * single-MCU image and bench.usb.elf for the USB MCU of the dual-MCU
+ * build. It runs every stage of the role once under simavr; see
+ * simbench.c for the stimuli.
+ */
+#include "bench.h"
+#include "config.h"
+#include "report.h"
+#include "settings.h"
+#include "timer.h"
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#if MCU_ROLE == MCU_ROLE_USB
+#include "link.h"
+#else
+#include "button.h"
+#endif
+
+#define bench_run(stage, call)                                                 \
+  do {                                                                         \
+    GPIOR0 = (stage);                                                          \
+    call;                                                                      \
+    GPIOR0 = BENCH_END;                                                        \
+    cli(); /* an ISR called directly returns with reti. */                     \
+  } while (0)
+
+// ISRs called directly instead of through the vector table.
+void USB_GEN_vect(void);
+void USB_COM_vect(void);
+void EE_READY_vect(void);
+#if MCU_ROLE == MCU_ROLE_USB
+void SPI_STC_vect(void);
+void PCINT0_vect(void);
+#endif
+
+volatile uint8_t sink;
+
+#if MCU_ROLE != MCU_ROLE_USB
+static void bench_input_scan() {
+  sink = get_buttons_lower;
+  sink = get_buttons_upper;
+  sink = get_stick_up;
+  sink = get_stick_down;
+  sink = get_stick_left;
+  sink = get_stick_right;
+}
+#endif
+
+int main(void) {
+#if MCU_ROLE == MCU_ROLE_USB
+  init_link();
+#else
+  report_t report = REPORT_NEUTRAL;
+
+  init_buttons();
+#endif
+  init_timer();
+
+  bench_run(BENCH_overhead, );
+#if MCU_ROLE == MCU_ROLE_USB
+  // One byte of a frame, then the rest of it unmeasured; SS is high
+  // (simbench drives PB0 high), so PCINT0 takes the publish path.
+  bench_run(BENCH_isr_spi_stc, SPI_STC_vect());
+  for (uint8_t i = 1; i < sizeof(report_t); i++) {
+    SPI_STC_vect();
+    cli();
+  }
+  bench_run(BENCH_isr_pcint0_publish, PCINT0_vect());
+#else
+  bench_run(BENCH_input_scan, bench_input_scan());
+  bench_run(BENCH_report_build, build_report(&report));
+#endif
+  bench_run(BENCH_isr_com_gamepad_in, USB_COM_vect());
+  bench_run(BENCH_isr_gen_end_of_reset, USB_GEN_vect());
+  bench_run(BENCH_isr_com_set_address, USB_COM_vect());
+  bench_run(BENCH_isr_com_get_device_descriptor, USB_COM_vect());
+  bench_run(BENCH_isr_com_get_configuration, USB_COM_vect());
+  // First byte of a record: settings_save() enabled the interrupt.
+  settings_save();
+  bench_run(BENCH_isr_ee_ready, EE_READY_vect());
+
+  GPIOR0 = BENCH_DONE;
+  while (1)
+    ;
+  return 0;
+}
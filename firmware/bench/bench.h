@@ -0,0 +1,33 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+/*
+ * Stages measured by `make bench`.
+ * Shared by the firmware driver (bench.c) and the simavr harness
+ * (simbench.c): the firmware writes the stage id to GPIOR0 when a stage
+ * starts and BENCH_END when it ends, the harness counts the cycles between
+ * both writes and prepares the stimuli of the stage on its start.
+ * An image runs only the stages of its role: the link ISRs exist in the
+ * USB MCU image, the input scan does not.
+ */
+#define BENCH_STAGES(X)                                                        \
+  X(1, overhead)                                                               \
+  X(2, input_scan)                                                             \
+  X(3, report_build)                                                           \
+  X(4, isr_com_gamepad_in)                                                     \
+  X(5, isr_gen_end_of_reset)                                                   \
+  X(6, isr_com_set_address)                                                    \
+  X(7, isr_com_get_device_descriptor)                                          \
+  X(8, isr_com_get_configuration)                                              \
+  X(9, isr_ee_ready)                                                           \
+  X(10, isr_spi_stc)                                                           \
+  X(11, isr_pcint0_publish)
+
+#define BENCH_ENUM(id, name) BENCH_##name = id,
+enum { BENCH_STAGES(BENCH_ENUM) BENCH_NUM_STAGES };
+#undef BENCH_ENUM
+
+#define BENCH_END (0x00)
+#define BENCH_DONE (0xFF)
+
+#endif
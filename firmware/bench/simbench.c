@@ -0,0 +1,274 @@
+/*
+ * Cycle-accurate benchmark of the firmware under simavr.
+ *
+ * Usage: simbench [-u] bench.elf baseline.txt
+ *
+ * Runs bench.elf (built by `make bench` for atmega32u4) to completion,
+ * prints the cycle count of every stage in bench.h the image ran and
+ * compares it with baseline.txt. Exits with 1 if a stage got slower than
+ * its baseline. With -u, baseline.txt is rewritten with the measured
+ * counts instead. Each image (bench.elf, bench.usb.elf) has its own
+ * baseline.
+ *
+ * The registers of the USB controller that usb.c polls are replaced
+ * with stand-ins: the host is always ready (TXINI), endpoints configure
+ * successfully (CFGOK) and the setup packets are fed through UEDATX, so no
+ * busy-wait of usb.c blocks. The other USB registers keep simavr's own
+ * model.
+ *
+ * A stage missing from baseline.txt is an error, not a pass.
+ */
+#include "bench.h"
+#include "avr_ioport.h"
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define F_CPU 16000000
+#define MAX_CYCLES 10000000
+
+// Data space addresses of the atmega32u4 registers.
+#define GPIOR0_ADDR 0x3E
+#define UDINT_ADDR 0xE1
+#define UEINTX_ADDR 0xE8
+#define UESTA0X_ADDR 0xEE
+#define UEDATX_ADDR 0xF1
+#define UEINT_ADDR 0xF4
+
+#define TXINI 0
+#define CFGOK 7
+#define RXSTPI 3
+#define EORSTI 3
+#define GAMEPAD_ENDPOINT_NUM 3
+
+typedef struct {
+  uint8_t ueintx;
+  uint8_t udint;
+  uint8_t ueint;
+  uint8_t setup[8];
+} stimulus_t;
+
+static const stimulus_t stimuli[BENCH_NUM_STAGES] = {
+    [BENCH_isr_com_gamepad_in] = {(1 << TXINI), 0, (1 << GAMEPAD_ENDPOINT_NUM)},
+    [BENCH_isr_gen_end_of_reset] = {0, (1 << EORSTI), 0},
+    [BENCH_isr_com_set_address] = {(1 << RXSTPI), 0, 0,
+                                   {0x00, 0x05, 0x12, 0x00, 0, 0, 0, 0}},
+    [BENCH_isr_com_get_device_descriptor] = {(1 << RXSTPI), 0, 0,
+                                             {0x80, 0x06, 0x00, 0x01, 0, 0,
+                                              0x40, 0}},
+    [BENCH_isr_com_get_configuration] = {(1 << RXSTPI), 0, 0,
+                                         {0x80, 0x08, 0, 0, 0, 0, 1, 0}},
+};
+
+#define BENCH_NAME(id, name) [id] = #name,
+static const char *const stage_names[BENCH_NUM_STAGES] = {
+    BENCH_STAGES(BENCH_NAME)};
+#undef BENCH_NAME
+
+static avr_cycle_count_t cycles[BENCH_NUM_STAGES];
+static uint8_t ran[BENCH_NUM_STAGES];
+static long baseline[BENCH_NUM_STAGES];
+static avr_cycle_count_t stage_start;
+static uint8_t stage;
+static uint8_t setup_pos;
+static int done;
+
+static void on_gpior0_write(avr_t *avr, avr_io_addr_t addr, uint8_t v,
+                            void *param) {
+  avr->data[addr] = v;
+  if (v == BENCH_DONE) {
+    done = 1;
+  } else if (v == BENCH_END) {
+    cycles[stage] = avr->cycle - stage_start;
+    stage = 0;
+  } else if (v < BENCH_NUM_STAGES) {
+    stage = v;
+    ran[v] = 1;
+    setup_pos = 0;
+    avr->data[UEINTX_ADDR] = stimuli[v].ueintx;
+    avr->data[UDINT_ADDR] = stimuli[v].udint;
+    avr->data[UEINT_ADDR] = stimuli[v].ueint;
+    stage_start = avr->cycle;
+  }
+}
+
+static uint8_t on_usb_read(avr_t *avr, avr_io_addr_t addr, void *param) {
+  switch (addr) {
+  case UEINTX_ADDR:
+    return avr->data[addr] | (1 << TXINI);
+  case UESTA0X_ADDR:
+    return (1 << CFGOK); // Every endpoint configuration succeeds.
+  case UEDATX_ADDR:
+    return setup_pos < 8 ? stimuli[stage].setup[setup_pos++] : 0;
+  default:
+    return avr->data[addr];
+  }
+}
+
+static void on_usb_write(avr_t *avr, avr_io_addr_t addr, uint8_t v,
+                         void *param) {
+  if (addr != UEDATX_ADDR) {
+    avr->data[addr] = v;
+  }
+}
+
+static const avr_io_addr_t stand_in_addrs[] = {
+    UDINT_ADDR, UEINTX_ADDR, UESTA0X_ADDR, UEDATX_ADDR, UEINT_ADDR,
+};
+
+static void take_over_io(avr_t *avr, avr_io_addr_t addr, avr_io_read_t r,
+                         avr_io_write_t w) {
+  // Drop the read/write callbacks of simavr's peripheral model for this
+  // one register first: avr_register_io_read() refuses to override them.
+  // IRQs of the model are not touched.
+  avr_io_addr_t io = AVR_DATA_TO_IO(addr);
+  memset(&avr->io[io].r, 0, sizeof(avr->io[io].r));
+  memset(&avr->io[io].w, 0, sizeof(avr->io[io].w));
+  if (r) {
+    avr_register_io_read(avr, addr, r, NULL);
+  }
+  if (w) {
+    avr_register_io_write(avr, addr, w, NULL);
+  }
+}
+
+static void drive_port(avr_t *avr, char port, uint8_t v) {
+  avr_raise_irq(
+      avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), IOPORT_IRQ_PIN_ALL), v);
+}
+
+static int read_baseline(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    return 0;
+  }
+  char line[128];
+  char name[64];
+  long value;
+  while (fgets(line, sizeof(line), fp)) {
+    if (line[0] == '#' || sscanf(line, "%63s %ld", name, &value) != 2) {
+      continue;
+    }
+    for (int i = 1; i < BENCH_NUM_STAGES; i++) {
+      if (strcmp(name, stage_names[i]) == 0) {
+        baseline[i] = value;
+      }
+    }
+  }
+  fclose(fp);
+  return 1;
+}
+
+static int write_baseline(const char *path) {
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    perror(path);
+    return 0;
+  }
+  fprintf(fp, "# stage cycles  (regenerate with `make bench-baseline`)\n");
+  for (int i = 1; i < BENCH_NUM_STAGES; i++) {
+    if (ran[i]) {
+      fprintf(fp, "%s %llu\n", stage_names[i], (unsigned long long)cycles[i]);
+    }
+  }
+  fclose(fp);
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  int update = 0;
+  if (argc > 1 && strcmp(argv[1], "-u") == 0) {
+    update = 1;
+    argc--;
+    argv++;
+  }
+  if (argc != 3) {
+    fprintf(stderr, "usage: simbench [-u] bench.elf baseline.txt\n");
+    return 2;
+  }
+
+  elf_firmware_t firmware = {0};
+  if (elf_read_firmware(argv[1], &firmware) != 0) {
+    fprintf(stderr, "simbench: cannot read %s\n", argv[1]);
+    return 2;
+  }
+  avr_t *avr = avr_make_mcu_by_name("atmega32u4");
+  if (!avr) {
+    fprintf(stderr, "simbench: atmega32u4 is not supported by simavr\n");
+    return 2;
+  }
+  avr_init(avr);
+  firmware.frequency = F_CPU;
+  avr_load_firmware(avr, &firmware);
+
+  take_over_io(avr, GPIOR0_ADDR, NULL, on_gpior0_write);
+  for (size_t i = 0; i < sizeof(stand_in_addrs) / sizeof(stand_in_addrs[0]);
+       i++) {
+    take_over_io(avr, stand_in_addrs[i], on_usb_read, on_usb_write);
+  }
+
+  // Inputs are active low: b0, b2, b5, b7, b9 and up-left are pressed.
+  // SS (PB0) of the USB MCU image is high: no frame in transfer.
+  drive_port(avr, 'B', (uint8_t) ~((1 << 4) | (1 << 6)));
+  drive_port(avr, 'C', 0xFF);
+  drive_port(avr, 'D', 0x5A);
+  drive_port(avr, 'F', (uint8_t) ~(1 << 1));
+
+  while (!done) {
+    const int state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed ||
+        avr->cycle > MAX_CYCLES) {
+      fprintf(stderr, "simbench: stopped in stage %s at cycle %llu\n",
+              stage ? stage_names[stage] : "-",
+              (unsigned long long)avr->cycle);
+      return 2;
+    }
+  }
+
+  // The marker writes themselves are measured by the overhead stage.
+  for (int i = 1; i < BENCH_NUM_STAGES; i++) {
+    if (ran[i] && i != BENCH_overhead) {
+      cycles[i] -= cycles[BENCH_overhead];
+    }
+  }
+
+  if (update) {
+    return write_baseline(argv[2]) ? 0 : 2;
+  }
+
+  if (!read_baseline(argv[2])) {
+    fprintf(stderr, "simbench: cannot read %s\n", argv[2]);
+    return 2;
+  }
+  int regressed = 0;
+  int missing = 0;
+  printf("%-32s %10s %10s %8s\n", "stage", "cycles", "baseline", "delta");
+  for (int i = 1; i < BENCH_NUM_STAGES; i++) {
+    if (!ran[i]) {
+      continue;
+    }
+    const long measured = (long)cycles[i];
+    if (baseline[i] == 0) {
+      printf("%-32s %10ld %10s %8s  NO BASELINE\n", stage_names[i], measured,
+             "-", "-");
+      missing = 1;
+      continue;
+    }
+    const long delta = measured - baseline[i];
+    printf("%-32s %10ld %10ld %+8ld%s\n", stage_names[i], measured,
+           baseline[i], delta, delta > 0 ? "  REGRESSED" : "");
+    if (delta > 0) {
+      regressed = 1;
+    }
+  }
+  if (missing) {
+    fprintf(stderr, "simbench: stages without baseline, run "
+                    "`make bench-baseline` and commit %s\n",
+            argv[2]);
+  }
+  return regressed || missing;
+}
@@ -1,9 +1,22 @@
 #include "button.h"
+#include "config.h"
+#include "link.h"
+#include "settings.h"
+#include "timer.h"
 #include "usb.h"
 #include <avr/io.h>
 
 int main(void) {
+  init_settings();
+#if MCU_ROLE == MCU_ROLE_USB
+  init_link();
+#else
   init_buttons();
+#endif
+  init_timer();
   usb_power_on();
+  // Everything else runs in the ISRs; returning would disable them.
+  while (1)
+    ;
   return 0;
 }
@@ -4,4 +4,33 @@
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #define min(a, b) ((a) < (b) ? (a) : (b))
 
+/*
+ * Firmware images, selected with -DMCU_ROLE=...
+ *   SINGLE : one MCU scans the inputs and serves USB.
+ *   SCANNER: scans the inputs at a fixed rate and sends reports over SPI.
+ *   USB    : serves USB with the newest report received over SPI.
+ */
+#define MCU_ROLE_SINGLE (0)
+#define MCU_ROLE_SCANNER (1)
+#define MCU_ROLE_USB (2)
+
+#ifndef MCU_ROLE
+#define MCU_ROLE MCU_ROLE_SINGLE
+#endif
+
+// Scan period of the scanner MCU.
+#ifndef SCAN_PERIOD_US
+#define SCAN_PERIOD_US (250)
+#endif
+
+// Time an input is held after a change, 0 to disable.
+// On the single-MCU image this is the default of the settings.
+#ifndef DEBOUNCE_MS
+#if MCU_ROLE == MCU_ROLE_SCANNER
+#define DEBOUNCE_MS (5)
+#else
+#define DEBOUNCE_MS (0)
+#endif
+#endif
+
 #endif
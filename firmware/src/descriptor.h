@@ -3,7 +3,16 @@
 
 #include <avr/pgmspace.h>
 
+#ifndef EXTENDED_REPORT
+#define EXTENDED_REPORT 0
+#endif
+
+#if EXTENDED_REPORT
+// Standard report + a sequence number and two Timer1 ticks.
+#define REPORT_DESCRIPTOR_SIZE (56 + 31)
+#else
 #define REPORT_DESCRIPTOR_SIZE (56)
+#endif
 
 // https://gist.github.com/DJm00n/a6bbcb810879daa9354dee4a02a6b34e
 // https://www.partsnotincluded.com/understanding-the-xbox-360-wired-controllers-usb-data/
@@ -89,7 +98,6 @@ static const uint8_t hid_descriptor[] PROGMEM = {
     REPORT_DESCRIPTOR_SIZE, 0x00, // wDescriptorLength[0] // report descriptor length
 };
 
-static const uint8_t REPORT_DESCRIPTOR_LENGTH = 0;
 static const uint8_t report_descriptor[] PROGMEM = {
     0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
     0x09, 0x05,                    // USAGE (Game Pad)
@@ -118,30 +126,27 @@ static const uint8_t report_descriptor[] PROGMEM = {
     0x81, 0x02,                    //   INPUT (Data,Var,Abs)
     0x95, 0x06,                    //   REPORT_COUNT (6)
     0x81, 0x03,                    //   INPUT (Cnst,Var,Abs)
+#if EXTENDED_REPORT
+    0x06, 0x00, 0xff,              //   USAGE_PAGE (Vendor Defined Page 1)
+    0x09, 0x01,                    //   USAGE (Vendor Usage 1: sequence)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x26, 0xff, 0x00,              //   LOGICAL_MAXIMUM (255)
+    0x75, 0x08,                    //   REPORT_SIZE (8)
+    0x95, 0x01,                    //   REPORT_COUNT (1)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+    0x09, 0x02,                    //   USAGE (Vendor Usage 2: sample tick)
+    0x09, 0x03,                    //   USAGE (Vendor Usage 3: commit tick)
+    0x27, 0xff, 0xff, 0x00, 0x00,  //   LOGICAL_MAXIMUM (65535)
+    0x75, 0x10,                    //   REPORT_SIZE (16)
+    0x95, 0x02,                    //   REPORT_COUNT (2)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+#endif
     0xc0                           // END_COLLECTION
 };
 
-// Data types that follows report
+#define REPORT_DESCRIPTOR_LENGTH (sizeof(report_descriptor))
 
-typedef struct {
-  int8_t BTN_GamePadButton1 : 1; // Usage 0x00090001: Button 1 Primary/trigger,
-                                 // Value =  to
-  int8_t BTN_GamePadButton2 : 1; // Usage 0x00090002: Button 2 Secondary, Value
-                                 // =  to
-  int8_t
-      BTN_GamePadButton3 : 1; // Usage 0x00090003: Button 3 Tertiary, Value = to
-  int8_t BTN_GamePadButton4 : 1;   // Usage 0x00090004: Button 4, Value =  to
-  int8_t BTN_GamePadButton5 : 1;   // Usage 0x00090005: Button 5, Value =  to
-  int8_t BTN_GamePadButton6 : 1;   // Usage 0x00090006: Button 6, Value =  to
-  int8_t BTN_GamePadButton7 : 1;   // Usage 0x00090007: Button 7, Value =  to
-  int8_t BTN_GamePadButton8 : 1;   // Usage 0x00090008: Button 8, Value =  to
-  int8_t BTN_GamePadButton9 : 1;   // Usage 0x00090009: Button 9, Value =  to
-  int8_t BTN_GamePadButton10 : 1;  // Usage 0x0009000A: Button 10, Value =  to
-  int8_t : 6;                      // Pad
-  uint8_t GD_GamePadHatSwitch : 4; // Usage 0x00010039: Hat switch, Value = 1 to
-                                   // 8, Physical = (Value - 1) x 4155 / 7 in
-  uint8_t : 4;                     // Pad
-  uint8_t pad_5;                   // Pad
-} controller_input_t;
+_Static_assert(sizeof(report_descriptor) == REPORT_DESCRIPTOR_SIZE,
+               "wDescriptorLength must match report_descriptor");
 
 #endif
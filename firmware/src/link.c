@@ -0,0 +1,105 @@
+#include "link.h"
+#include "config.h"
+#include "timer.h"
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#if MCU_ROLE == MCU_ROLE_SCANNER
+
+void init_link() {
+  // PB0 (SS), PB1 (SCK) and PB2 (MOSI) as outputs, SS idles high.
+  PORTB |= (1 << PORTB0);
+  DDRB |= (1 << DDB0) | (1 << DDB1) | (1 << DDB2);
+  // SPI enabled, master, clk/16.
+  SPCR = (1 << SPE) | (1 << MSTR) | (1 << SPR0);
+}
+
+void link_send_report(report_t *const report) {
+#if EXTENDED_REPORT
+  // The clocks of both MCUs are not related: send the send tick in
+  // commit_tick so that the USB MCU can rebase sample_tick on its own.
+  // Stamped right before SS falls; the transfer is added on the USB MCU.
+  report->commit_tick = get_timer_tick;
+#endif
+  uint8_t const *const dat = (uint8_t const *)report;
+  PORTB &= ~(1 << PORTB0);
+  for (uint8_t i = 0; i < sizeof(report_t); i++) {
+    SPDR = dat[i];
+    while (!(SPSR & (1 << SPIF)))
+      ;
+  }
+  PORTB |= (1 << PORTB0);
+}
+
+#elif MCU_ROLE == MCU_ROLE_USB
+
+#define LINK_STALE_TICKS (LINK_STALE_SCANS * SCAN_PERIOD_US / TIMER_TICK_US)
+
+static const report_t neutral = REPORT_NEUTRAL;
+static report_t frames[2] = {REPORT_NEUTRAL, REPORT_NEUTRAL};
+static uint8_t latest; // frames[latest] is never written by the ISRs.
+static uint8_t received;
+static uint8_t stale = 1;
+static uint16_t published_tick;
+
+void init_link() {
+  // PB3 (MISO) as output, SS is pulled-up while the scanner boots.
+  DDRB |= (1 << DDB3);
+  PORTB |= (1 << PORTB0);
+  // SPI enabled, slave, interrupt on every byte.
+  SPCR = (1 << SPIE) | (1 << SPE);
+  // Pin change interrupt of SS (PCINT0) to delimit frames.
+  PCMSK0 |= (1 << PCINT0);
+  PCICR |= (1 << PCIE0);
+}
+
+static inline void receive_byte() {
+  const uint8_t v = SPDR;
+  if (received < sizeof(report_t)) {
+    ((uint8_t *)&frames[!latest])[received] = v;
+  }
+  received++;
+}
+
+ISR(SPI_STC_vect) { receive_byte(); }
+
+ISR(PCINT0_vect) {
+  const uint8_t ss_high = PINB & (1 << PINB0);
+  if (!ss_high) {
+    // SS fell: a new frame starts, and a byte already pending is its first.
+    received = 0;
+  }
+  // PCINT0 outranks SPI_STC: when both are pending, e.g. after a long USB
+  // ISR, take the pending byte first. Reading SPSR then SPDR clears SPIF
+  // and so the pending SPI interrupt.
+  if (SPSR & (1 << SPIF)) {
+    receive_byte();
+  }
+  if (!ss_high) {
+    return;
+  }
+  if (received == sizeof(report_t)) {
+    const uint16_t now = get_timer_tick;
+#if EXTENDED_REPORT
+    report_t *const frame = &frames[!latest];
+    // Rebase the sample tick on the local Timer1 by its age at send and
+    // the transfer time.
+    frame->sample_tick = now - LINK_TRANSFER_TICKS -
+                         (uint16_t)(frame->commit_tick - frame->sample_tick);
+#endif
+    latest = !latest;
+    published_tick = now;
+    stale = 0;
+  }
+  received = 0;
+}
+
+void link_latest_report(report_t *const report) {
+  // Called at every IN token, well within the 262 ms wrap of Timer1.
+  if ((uint16_t)(get_timer_tick - published_tick) > LINK_STALE_TICKS) {
+    stale = 1;
+  }
+  *report = stale ? neutral : frames[latest];
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __LINK_H__
+#define __LINK_H__
+
+#include "report.h"
+
+/*
+ * SPI link between the scanner MCU (master) and the USB MCU (slave).
+ * A frame is one report_t sent while SS (PB0) is low. The USB MCU
+ * publishes a frame on the rising edge of SS only when all its bytes
+ * arrived, so frames broken by a late SPI interrupt are dropped. When no
+ * frame was published for LINK_STALE_SCANS scan periods, e.g. the scanner
+ * is hung or not flashed, the USB MCU reports nothing pressed.
+ *
+ * Latency budget per stage, from pin change to the USB FIFO:
+ *   wait for the next scan                      <= SCAN_PERIOD_US
+ *   scan, debounce and pack (scanner)           <  20 us
+ *   transfer, 1 MHz SCK                         <  sizeof(report_t) x 9 us
+ *   publish on SS rise (USB MCU)                <  5 us
+ *   wait for the next IN token (bInterval)      <= 4 ms
+ *   copy into the endpoint FIFO (USB MCU)       <  10 us
+ */
+
+#define LINK_STALE_SCANS (8)
+
+/*
+ * SPI transfer of a frame in Timer1 ticks: 8 bits at clk/16 plus the
+ * polling loop per byte. The scanner sends with interrupts disabled, so
+ * this is constant.
+ */
+#define LINK_BYTE_CYCLES (8 * 16 + 10)
+#define LINK_TRANSFER_TICKS (sizeof(report_t) * LINK_BYTE_CYCLES / 64)
+
+void init_link();
+
+// Scanner MCU: blocks until the frame is sent.
+void link_send_report(report_t *const);
+
+// USB MCU: copy the newest complete frame. Call with interrupts disabled.
+void link_latest_report(report_t *const);
+
+#endif
@@ -0,0 +1,100 @@
+#include "report.h"
+#include "button.h"
+#include "config.h"
+#include "settings.h"
+#include "timer.h"
+#include <avr/io.h>
+
+/*
+ * Hat switch values indexed by (right, left, down, up) pressed bits.
+ * Opposite directions cancel each other. 8 is out of the logical range and
+ * reported as null (neutral).
+ */
+static const uint8_t hat_table[16] = {
+    8, 0, 4, 8, // none,  up,         down,       up+down
+    6, 7, 5, 6, // left,  up-left,    down-left,  up+down+left
+    2, 1, 3, 2, // right, up-right,   down-right, up+down+right
+    8, 0, 4, 8, // left+right ...
+};
+
+#define NUM_INPUTS (14)
+
+/*
+ * Pressed inputs as bits:
+ *   13..10: right, left, down, up
+ *    9.. 0: b9 .. b0
+ */
+static uint16_t scan_inputs() {
+  // All inputs are pulled-up; a pressed switch reads 0.
+  const uint8_t lower = ~get_buttons_lower;
+  const uint8_t upper = ~get_buttons_upper;
+  const uint8_t stick = (!get_stick_up) | (!get_stick_down << 1) |
+                        (!get_stick_left << 2) | (!get_stick_right << 3);
+  return lower | ((uint16_t)(upper & 0x03) << 8) | ((uint16_t)stick << 10);
+}
+
+/*
+ * Eager debounce: a change is reported at once, then the input ignores
+ * further changes for the debounce time, measured on Timer1 so that it
+ * does not depend on how often build_report() is called. That is every
+ * scan period on the scanner MCU, but every IN token (the host polling
+ * interval) on the single-MCU image, which also bounds how soon a change
+ * can be seen there. Fixed to DEBOUNCE_MS on the scanner MCU, taken from
+ * the settings otherwise.
+ */
+#if MCU_ROLE == MCU_ROLE_SCANNER
+#define debounce_ms (DEBOUNCE_MS)
+#else
+#define debounce_ms (settings.debounce_ms)
+#endif
+
+static uint16_t debounced;
+static uint16_t locked;
+static uint16_t changed_tick[NUM_INPUTS];
+
+static uint16_t debounce(const uint16_t raw, const uint16_t now) {
+  if (!debounce_ms) {
+    debounced = raw;
+    locked = 0;
+    return raw;
+  }
+  // At most 255 ms: 63750 ticks, within the 16 bit Timer1.
+  const uint16_t window = (uint16_t)debounce_ms * (1000 / TIMER_TICK_US);
+  for (uint8_t i = 0; i < NUM_INPUTS; i++) {
+    const uint16_t bit = (uint16_t)1 << i;
+    if ((locked & bit) && (uint16_t)(now - changed_tick[i]) >= window) {
+      locked &= ~bit;
+    }
+    if (!(locked & bit) && ((raw ^ debounced) & bit)) {
+      debounced ^= bit;
+      locked |= bit;
+      changed_tick[i] = now;
+    }
+  }
+  return debounced;
+}
+
+void build_report(report_t *const report) {
+  const uint16_t now = get_timer_tick;
+#if EXTENDED_REPORT
+  report->sample_tick = now;
+#endif
+  const uint16_t inputs = debounce(scan_inputs(), now);
+
+#if EXTENDED_REPORT
+  controller_input_t *const input = &report->input;
+#else
+  controller_input_t *const input = report;
+#endif
+  input->BTN_GamePadButton1 = !!(inputs & (1 << 0));
+  input->BTN_GamePadButton2 = !!(inputs & (1 << 1));
+  input->BTN_GamePadButton3 = !!(inputs & (1 << 2));
+  input->BTN_GamePadButton4 = !!(inputs & (1 << 3));
+  input->BTN_GamePadButton5 = !!(inputs & (1 << 4));
+  input->BTN_GamePadButton6 = !!(inputs & (1 << 5));
+  input->BTN_GamePadButton7 = !!(inputs & (1 << 6));
+  input->BTN_GamePadButton8 = !!(inputs & (1 << 7));
+  input->BTN_GamePadButton9 = !!(inputs & (1 << 8));
+  input->BTN_GamePadButton10 = !!(inputs & (1 << 9));
+  input->GD_GamePadHatSwitch = hat_table[inputs >> 10];
+}
@@ -0,0 +1,73 @@
+#ifndef __REPORT_H__
+#define __REPORT_H__
+
+#include <stdint.h>
+
+#ifndef EXTENDED_REPORT
+#define EXTENDED_REPORT 0
+#endif
+
+// Data types that follows report
+
+/*
+ * Fields in the order of report_descriptor; avr-gcc allocates bit-fields
+ * from the LSB. The pads are named: unnamed bit-fields are not set by an
+ * initializer, and build_report() leaves them alone.
+ *   byte 0: hat switch, pad
+ *   byte 1: buttons 1-8
+ *   byte 2: buttons 9-10, pad
+ */
+typedef struct {
+  uint8_t GD_GamePadHatSwitch : 4; // Usage 0x00010039: Hat switch, Value = 0 to
+                                   // 7, Physical = Value x 45 deg, 8: null
+  uint8_t pad_hat : 4;             // Pad
+  uint8_t BTN_GamePadButton1 : 1;  // Usage 0x00090001: Button 1 Primary/trigger
+  uint8_t BTN_GamePadButton2 : 1;  // Usage 0x00090002: Button 2 Secondary
+  uint8_t BTN_GamePadButton3 : 1;  // Usage 0x00090003: Button 3 Tertiary
+  uint8_t BTN_GamePadButton4 : 1;  // Usage 0x00090004: Button 4
+  uint8_t BTN_GamePadButton5 : 1;  // Usage 0x00090005: Button 5
+  uint8_t BTN_GamePadButton6 : 1;  // Usage 0x00090006: Button 6
+  uint8_t BTN_GamePadButton7 : 1;  // Usage 0x00090007: Button 7
+  uint8_t BTN_GamePadButton8 : 1;  // Usage 0x00090008: Button 8
+  uint8_t BTN_GamePadButton9 : 1;  // Usage 0x00090009: Button 9
+  uint8_t BTN_GamePadButton10 : 1; // Usage 0x0009000A: Button 10
+  uint8_t pad_buttons : 6;         // Pad
+} controller_input_t;
+
+_Static_assert(sizeof(controller_input_t) == 3,
+               "controller_input_t must match report_descriptor");
+
+/*
+ * Extended report, enabled by building with EXTENDED_REPORT=1.
+ * Both ticks are Timer1 counts (see timer.h) so that the host can compute
+ * the on-device age of the inputs as (commit_tick - sample_tick) and detect
+ * dropped reports from gaps in the sequence.
+ */
+typedef struct {
+  controller_input_t input;
+  uint8_t sequence;     // Usage 0xFF000001: incremented on every report
+  uint16_t sample_tick; // Usage 0xFF000002: Timer1 tick when pins were read
+  uint16_t commit_tick; // Usage 0xFF000003: Timer1 tick when sent to FIFO
+} controller_input_ext_t;
+
+#ifdef __AVR__
+_Static_assert(sizeof(controller_input_ext_t) == 8,
+               "controller_input_ext_t must match report_descriptor");
+#endif
+
+#if EXTENDED_REPORT
+typedef controller_input_ext_t report_t;
+#else
+typedef controller_input_t report_t;
+#endif
+
+// Nothing pressed: hat switch 8 is null, 0 would be up. Also clears the pads.
+#if EXTENDED_REPORT
+#define REPORT_NEUTRAL {.input = {.GD_GamePadHatSwitch = 8}}
+#else
+#define REPORT_NEUTRAL {.GD_GamePadHatSwitch = 8}
+#endif
+
+void build_report(report_t *const);
+
+#endif
@@ -0,0 +1,30 @@
+#include "button.h"
+#include "config.h"
+#include "link.h"
+#include "report.h"
+#include "timer.h"
+#include <avr/io.h>
+
+#define SCAN_PERIOD_TICKS (SCAN_PERIOD_US / TIMER_TICK_US)
+
+/*
+ * Entry point of the scanner MCU (MCU_ROLE_SCANNER).
+ * Nothing but the scan runs here: no interrupt is enabled.
+ */
+int main(void) {
+  init_buttons();
+  init_timer();
+  init_link();
+
+  uint16_t next_scan = get_timer_tick;
+  while (1) {
+    while ((int16_t)(get_timer_tick - next_scan) < 0)
+      ;
+    next_scan += SCAN_PERIOD_TICKS;
+
+    report_t report = REPORT_NEUTRAL;
+    build_report(&report);
+    link_send_report(&report);
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include "settings.h"
+#include "config.h"
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/crc16.h>
+
+/*
+ * The EEPROM is a ring of fixed-size records, written in turn to level
+ * the wear. The newest record is the valid one with the greatest counter;
+ * a record torn by a power loss fails its CRC and is skipped.
+ */
+typedef struct {
+  uint8_t version;
+  uint16_t counter;
+  settings_t settings;
+  uint8_t crc; // CRC-8 (CCITT) of the bytes above
+} record_t;
+
+#define RECORD_SIZE (sizeof(record_t))
+#define NUM_RECORDS ((E2END + 1) / RECORD_SIZE)
+
+settings_t settings = {
+    .debounce_ms = DEBOUNCE_MS,
+};
+
+static uint8_t next_slot;
+static uint16_t next_counter;
+
+// Record being written by the EE_READY ISR.
+static record_t pending;
+static uint8_t pending_slot;
+static uint8_t written;
+static uint8_t writing;
+static uint8_t dirty;
+
+static uint8_t record_crc(const record_t *const record) {
+  uint8_t crc = 0;
+  uint8_t const *const dat = (uint8_t const *)record;
+  for (uint8_t i = 0; i < RECORD_SIZE - 1; i++) {
+    crc = _crc8_ccitt_update(crc, dat[i]);
+  }
+  return crc;
+}
+
+void init_settings() {
+  record_t record;
+  uint8_t found = 0;
+  uint16_t newest = 0;
+  for (uint8_t slot = 0; slot < NUM_RECORDS; slot++) {
+    eeprom_read_block(&record, (const void *)(uint16_t)(slot * RECORD_SIZE),
+                      RECORD_SIZE);
+    if (record.version != SETTINGS_VERSION ||
+        record.crc != record_crc(&record)) {
+      continue;
+    }
+    // Counters of the ring are consecutive, so this is wrap-safe.
+    if (!found || (int16_t)(record.counter - newest) > 0) {
+      found = 1;
+      newest = record.counter;
+      settings = record.settings;
+      next_slot = slot + 1 < NUM_RECORDS ? slot + 1 : 0;
+    }
+  }
+  next_counter = newest + 1;
+}
+
+static void start_record() {
+  pending.version = SETTINGS_VERSION;
+  pending.counter = next_counter++;
+  pending.settings = settings;
+  pending.crc = record_crc(&pending);
+  pending_slot = next_slot;
+  next_slot = next_slot + 1 < NUM_RECORDS ? next_slot + 1 : 0;
+  written = 0;
+  writing = 1;
+  EECR |= (1 << EERIE);
+}
+
+void settings_save() {
+  const uint8_t sreg = SREG;
+  cli();
+  if (writing) {
+    dirty = 1;
+  } else {
+    start_record();
+  }
+  SREG = sreg;
+}
+
+/*
+ * One byte per interrupt: an EEPROM write takes 3.4 ms, during which the
+ * CPU keeps running the scan and the USB ISRs.
+ */
+ISR(EE_READY_vect) {
+  if (written < RECORD_SIZE) {
+    EEAR = pending_slot * RECORD_SIZE + written;
+    EEDR = ((uint8_t const *)&pending)[written];
+    written++;
+    EECR |= (1 << EEMPE);
+    EECR |= (1 << EEPE);
+  } else if (dirty) {
+    dirty = 0;
+    start_record();
+  } else {
+    writing = 0;
+    EECR &= ~(1 << EERIE);
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef __SETTINGS_H__
+#define __SETTINGS_H__
+
+#include <stdint.h>
+
+/*
+ * Settings kept in RAM and journaled in EEPROM.
+ * Bump SETTINGS_VERSION when the layout changes: records of another
+ * version are ignored and the defaults are used instead.
+ */
+#define SETTINGS_VERSION (1)
+
+typedef struct {
+  uint8_t debounce_ms; // Time an input is held after a change, 0: off
+  uint8_t reserved[11];
+} settings_t;
+
+/*
+ * Only the single-MCU image applies the settings. The USB MCU image
+ * stalls both GET_SETTINGS and SET_SETTING: its scanner uses its own
+ * compile-time DEBOUNCE_MS, which the USB MCU does not know.
+ */
+
+extern settings_t settings;
+
+// Load the newest valid record, or the defaults. Call before sei().
+void init_settings();
+
+// Journal the current settings without blocking. Saves requested while a
+// record is being written are coalesced into the next record.
+void settings_save();
+
+#endif
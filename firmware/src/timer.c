@@ -0,0 +1,9 @@
+#include "timer.h"
+#include <avr/io.h>
+
+void init_timer() {
+  // Normal mode, no compare outputs, clk/64.
+  TCCR1A = 0x00;
+  TCCR1B = (1 << CS11) | (1 << CS10);
+  TCNT1 = 0;
+}
@@ -0,0 +1,14 @@
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+/*
+ * Timer1 is free-running with clk/64 prescaler:
+ * a tick is 4 us at 16 MHz and the counter wraps every 262 ms.
+ */
+#define TIMER_TICK_US (4)
+
+#define get_timer_tick (TCNT1)
+
+void init_timer();
+
+#endif
@@ -1,8 +1,13 @@
 #include "usb.h"
 #include "config.h"
 #include "descriptor.h"
+#include "link.h"
+#include "report.h"
+#include "settings.h"
+#include "timer.h"
 #include <avr/interrupt.h>
 #include <avr/io.h>
+#include <stddef.h>
 
 const uint8_t GET_STATUS = 0x00;
 const uint8_t CLEAR_FEATURE = 0x01;
@@ -24,6 +29,10 @@ const uint8_t SET_REPORT = 0x09;
 const uint8_t SET_IDLE = 0x0A;
 const uint8_t SET_PROTOCOL = 0x0B;
 
+// Vendor Request
+const uint8_t GET_SETTINGS = 0x01; // Data stage: settings_t
+const uint8_t SET_SETTING = 0x02;  // wIndex: byte offset, wValue: new value
+
 const uint8_t ENDPOINT_SIZE = 32;
 const uint8_t ENDPOINT_SIZE_SEL = 0x22;
 
@@ -117,7 +126,7 @@ void handle_udint() {
     UECFG1X |= ENDPOINT_SIZE_SEL; // 32 byte endpoint, allocate a memory for the
                                   // endpoint.
 
-    if (UESTA0X & (1 << CFGOK)) {
+    if (!(UESTA0X & (1 << CFGOK))) {
       while (1)
         ;
     }
@@ -159,8 +168,8 @@ ISR(USB_GEN_vect) {
   }
 }
 
-void send_descriptor(const uint8_t wValue, const uint8_t wIndex,
-                     const uint8_t wLength) {
+void send_descriptor(const uint16_t wValue, const uint16_t wIndex,
+                     const uint16_t wLength) {
   uint8_t const *descriptor;
   uint8_t descriptor_length;
   switch (wValue & 0xFF00) {
@@ -195,7 +204,7 @@ void send_descriptor(const uint8_t wValue, const uint8_t wIndex,
   default:
     // Unexpected descriptor type.
     UECONX |= (1 << STALLRQ);
-    break;
+    return;
   }
   uint8_t request_length = min(255, wLength);
   descriptor_length = min(request_length, descriptor_length);
@@ -213,6 +222,23 @@ void send_descriptor(const uint8_t wValue, const uint8_t wIndex,
   }
 }
 
+// Byte offsets of settings_t that SET_SETTING may change.
+static uint8_t settings_readable() {
+#if MCU_ROLE == MCU_ROLE_USB
+  return 0; // Would report the defaults, not the scanner's, see settings.h.
+#else
+  return 1;
+#endif
+}
+
+static uint8_t settings_writable(const uint16_t offset) {
+#if MCU_ROLE == MCU_ROLE_USB
+  return 0; // Not applied on this image, see settings.h.
+#else
+  return offset == offsetof(settings_t, debounce_ms);
+#endif
+}
+
 void send_report() {
   // TODO:
 }
@@ -361,11 +387,47 @@ void handle_control_setup() {
     } else {
       send_stall();
     }
+  } else if (request_kind == 0x02) { // Handle vendor requests.
+    if (recipient == 0x00 && request_direction == 1 &&
+        bRequest == GET_SETTINGS && settings_readable()) {
+      send_ram_bytes((uint8_t const *)&settings,
+                     min(wLength, sizeof(settings_t)));
+    } else if (recipient == 0x00 && request_direction == 0 &&
+               bRequest == SET_SETTING && settings_writable(wIndex)) {
+      // Applied at once; the EEPROM is written in the background.
+      ((uint8_t *)&settings)[wIndex] = (uint8_t)wValue;
+      settings_save();
+      send_zero_length_packet();
+    } else {
+      send_stall();
+    }
   }
 }
 
+#if EXTENDED_REPORT
+static uint8_t report_sequence;
+#endif
+
 void send_gamepad_data() {
-  // TODO:
+  report_t report = REPORT_NEUTRAL;
+#if MCU_ROLE == MCU_ROLE_USB
+  link_latest_report(&report);
+#else
+  build_report(&report);
+#endif
+
+  UENUM = GAMEPAD_ENDPOINT_NUM;
+  UEINTX &= ~(1 << TXINI);
+#if EXTENDED_REPORT
+  // Stamp as late as possible: right before the bytes go into the FIFO.
+  report.sequence = report_sequence++;
+  report.commit_tick = get_timer_tick;
+#endif
+  uint8_t const *const dat = (uint8_t const *)&report;
+  for (uint8_t i = 0; i < sizeof(report); i++) {
+    UEDATX = dat[i];
+  }
+  UEINTX &= ~(1 << FIFOCON);
 }
 
 ISR(USB_COM_vect) {
@@ -0,0 +1,483 @@
+/*
+ * Streaming analyzer of report captures.
+ *
+ * Usage: trace_analyzer [-f hex|bin] [-j threads] [-w bounce_us] capture
+ *
+ * A capture is a sequence of extended reports (EXTENDED_REPORT=1, see
+ * firmware/src/report.h), 8 bytes each:
+ *   input[3], sequence, sample_tick (LE16), commit_tick (LE16)
+ * with input[] laid out as report_descriptor: hat, buttons 1-8, 9-10.
+ * either raw (bin) or as hex-ASCII with one report per line, as printed by
+ * debug_send_hex() of tools/uart_tx_test. Lines that do not decode to a
+ * report are counted as malformed and skipped.
+ *
+ * The capture is memory-mapped and split into one chunk per thread; every
+ * chunk is decoded in a single pass and the chunks are stitched together
+ * at their boundaries afterwards. A JSON summary is printed on stdout.
+ */
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr size_t RECORD_SIZE = 8;
+constexpr double TICK_US = 4.0; // Timer1 at clk/64, see firmware/src/timer.h
+constexpr size_t HIST_SIZE = 1 << 16;
+
+// 10 buttons followed by the 4 directions of the hat switch.
+constexpr int NUM_INPUTS = 14;
+const char *const INPUT_NAMES[NUM_INPUTS] = {
+    "b1", "b2", "b3", "b4", "b5", "b6", "b7",
+    "b8", "b9", "b10", "up", "down", "left", "right",
+};
+
+enum { UP = 1 << 10, DOWN = 1 << 11, LEFT = 1 << 12, RIGHT = 1 << 13 };
+const uint16_t HAT_TO_DIRECTIONS[16] = {
+    UP, UP | RIGHT, RIGHT, DOWN | RIGHT, DOWN, DOWN | LEFT, LEFT, UP | LEFT,
+    0,  0,          0,     0,            0,    0,           0,    0,
+};
+
+enum class Format { HEX, BIN };
+
+struct Record {
+  uint16_t inputs; // bit per INPUT_NAMES entry, 1: pressed
+  uint8_t sequence;
+  uint16_t sample_tick;
+  uint16_t commit_tick;
+};
+
+Record decode(const uint8_t *const b) {
+  Record r;
+  r.inputs = HAT_TO_DIRECTIONS[b[0] & 0x0F] | b[1] | ((b[2] & 0x03) << 8);
+  r.sequence = b[3];
+  r.sample_tick = b[4] | (b[5] << 8);
+  r.commit_tick = b[6] | (b[7] << 8);
+  return r;
+}
+
+struct Stats {
+  std::vector<uint64_t> latency_hist = std::vector<uint64_t>(HIST_SIZE);
+  std::vector<uint64_t> interval_hist = std::vector<uint64_t>(HIST_SIZE);
+  uint64_t records = 0;
+  uint64_t malformed = 0;
+  uint64_t gaps = 0;
+  uint64_t missing = 0;
+  uint64_t duplicates = 0;
+  std::array<uint64_t, NUM_INPUTS> presses{};
+  std::array<uint64_t, NUM_INPUTS> bounces{};
+};
+
+/*
+ * Everything a chunk needs to be stitched to its neighbours: its first and
+ * last reports and, per input, the first and last transitions seen inside
+ * the chunk in ticks since its first report.
+ */
+struct Chunk {
+  Stats stats;
+  Record first{};
+  Record last{};
+  uint64_t elapsed = 0;
+  std::array<int64_t, NUM_INPUTS> first_transition;
+  std::array<int64_t, NUM_INPUTS> last_transition;
+};
+
+class Analyzer {
+public:
+  explicit Analyzer(const uint32_t bounce_window) : window(bounce_window) {
+    first_transition.fill(-1);
+    last_transition.fill(-1);
+  }
+
+  // Consume the next report at `now` ticks since the first one.
+  void transition_to(const Record &r, const int64_t now, Stats &stats) {
+    uint16_t changed = r.inputs ^ state;
+    state = r.inputs;
+    while (changed) {
+      const int i = __builtin_ctz(changed);
+      changed &= changed - 1;
+      if (last_transition[i] < 0) {
+        first_transition[i] = now;
+      } else if (now - last_transition[i] < window) {
+        stats.bounces[i]++;
+      }
+      last_transition[i] = now;
+      if (r.inputs & (1 << i)) {
+        stats.presses[i]++;
+      }
+    }
+  }
+
+  // Reports go out at commit_tick; sample_tick only times the inputs.
+  void step(const Record &prev, const Record &r, Stats &stats) {
+    stats.interval_hist[(uint16_t)(r.commit_tick - prev.commit_tick)]++;
+    const uint8_t seq_delta = r.sequence - prev.sequence;
+    if (seq_delta == 0) {
+      stats.duplicates++;
+    } else if (seq_delta > 1) {
+      stats.gaps++;
+      stats.missing += seq_delta - 1;
+    }
+  }
+
+  uint16_t state = 0;
+  std::array<int64_t, NUM_INPUTS> first_transition;
+  std::array<int64_t, NUM_INPUTS> last_transition;
+
+private:
+  const int64_t window;
+};
+
+template <typename F>
+void for_each_hex_record(const char *p, const char *const end, Stats &stats,
+                         F &&f) {
+  while (p < end) {
+    const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+    if (!eol) {
+      eol = end;
+    }
+    uint8_t bytes[RECORD_SIZE];
+    size_t n = 0;
+    int nibble = -1;
+    bool ok = true;
+    for (const char *c = p; c < eol && ok; c++) {
+      int v;
+      if (*c >= '0' && *c <= '9') {
+        v = *c - '0';
+      } else if (*c >= 'A' && *c <= 'F') {
+        v = *c - 'A' + 10;
+      } else if (*c >= 'a' && *c <= 'f') {
+        v = *c - 'a' + 10;
+      } else if (*c == ' ' || *c == '\t' || *c == '\r') {
+        continue;
+      } else {
+        ok = false;
+        break;
+      }
+      if (nibble < 0) {
+        nibble = v;
+      } else if (n < RECORD_SIZE) {
+        bytes[n++] = (nibble << 4) | v;
+        nibble = -1;
+      } else {
+        ok = false;
+      }
+    }
+    if (ok && n == RECORD_SIZE && nibble < 0) {
+      f(decode(bytes));
+    } else if (eol - p > 1 || (eol - p == 1 && *p != '\r')) {
+      stats.malformed++; // not counting empty lines
+    }
+    p = eol + 1;
+  }
+}
+
+void analyze_chunk(const uint8_t *const begin, const uint8_t *const end,
+                   const Format format, const uint32_t bounce_window,
+                   Chunk &chunk) {
+  Analyzer analyzer(bounce_window);
+  Stats &stats = chunk.stats;
+  int64_t now = 0;
+  auto consume = [&](const Record &r) {
+    stats.latency_hist[(uint16_t)(r.commit_tick - r.sample_tick)]++;
+    if (stats.records == 0) {
+      chunk.first = r;
+      analyzer.state = r.inputs;
+    } else {
+      analyzer.step(chunk.last, r, stats);
+      now += (uint16_t)(r.sample_tick - chunk.last.sample_tick);
+      analyzer.transition_to(r, now, stats);
+    }
+    chunk.last = r;
+    stats.records++;
+  };
+
+  if (format == Format::BIN) {
+    const uint8_t *p = begin;
+    for (; p + RECORD_SIZE <= end; p += RECORD_SIZE) {
+      consume(decode(p));
+    }
+    if (p < end) {
+      stats.malformed++; // truncated last record
+    }
+  } else {
+    for_each_hex_record(reinterpret_cast<const char *>(begin),
+                        reinterpret_cast<const char *>(end), stats, consume);
+  }
+
+  // Bounces of the first transitions are only known after stitching.
+  chunk.elapsed = now;
+  chunk.first_transition = analyzer.first_transition;
+  chunk.last_transition = analyzer.last_transition;
+}
+
+/*
+ * Replays the boundary between every pair of chunks: the interval and the
+ * sequence step between them, the input changes of the first report of a
+ * chunk, and the bounces whose previous transition lies in an earlier chunk.
+ */
+Stats stitch(std::vector<Chunk> &chunks, const uint32_t bounce_window) {
+  Stats total;
+  Analyzer analyzer(bounce_window);
+  bool has_prev = false;
+  Record prev{};
+  int64_t offset = 0;
+  for (Chunk &chunk : chunks) {
+    const Stats &s = chunk.stats;
+    if (s.records == 0) {
+      total.malformed += s.malformed;
+      continue;
+    }
+    if (has_prev) {
+      analyzer.step(prev, chunk.first, total);
+      offset += (uint16_t)(chunk.first.sample_tick - prev.sample_tick);
+      analyzer.transition_to(chunk.first, offset, total);
+    } else {
+      analyzer.state = chunk.first.inputs;
+    }
+    for (int i = 0; i < NUM_INPUTS; i++) {
+      const int64_t first = chunk.first_transition[i];
+      if (first >= 0 && analyzer.last_transition[i] >= 0 &&
+          offset + first - analyzer.last_transition[i] < bounce_window) {
+        total.bounces[i]++;
+      }
+      if (chunk.last_transition[i] >= 0) {
+        analyzer.last_transition[i] = offset + chunk.last_transition[i];
+      }
+    }
+    analyzer.state = chunk.last.inputs;
+    offset += chunk.elapsed;
+    prev = chunk.last;
+    has_prev = true;
+
+    for (size_t t = 0; t < HIST_SIZE; t++) {
+      total.latency_hist[t] += s.latency_hist[t];
+      total.interval_hist[t] += s.interval_hist[t];
+    }
+    total.records += s.records;
+    total.malformed += s.malformed;
+    total.gaps += s.gaps;
+    total.missing += s.missing;
+    total.duplicates += s.duplicates;
+    for (int i = 0; i < NUM_INPUTS; i++) {
+      total.presses[i] += s.presses[i];
+      total.bounces[i] += s.bounces[i];
+    }
+  }
+  return total;
+}
+
+void print_distribution(const char *const name,
+                        const std::vector<uint64_t> &hist, const bool last) {
+  uint64_t count = 0;
+  double sum = 0;
+  for (size_t t = 0; t < HIST_SIZE; t++) {
+    count += hist[t];
+    sum += (double)t * hist[t];
+  }
+  printf("  \"%s\": {\"count\": %llu", name, (unsigned long long)count);
+  if (count) {
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    const char *const labels[] = {"p50", "p90", "p99", "p999"};
+    size_t min = 0;
+    while (hist[min] == 0) {
+      min++;
+    }
+    size_t max = HIST_SIZE - 1;
+    while (hist[max] == 0) {
+      max--;
+    }
+    printf(", \"min\": %.0f, \"mean\": %.3f", min * TICK_US,
+           sum / count * TICK_US);
+    uint64_t seen = 0;
+    size_t t = 0;
+    for (int q = 0; q < 4; q++) {
+      const uint64_t rank = (uint64_t)(quantiles[q] * (count - 1)) + 1;
+      while (seen + hist[t] < rank) {
+        seen += hist[t++];
+      }
+      printf(", \"%s\": %.0f", labels[q], t * TICK_US);
+    }
+    printf(", \"max\": %.0f", max * TICK_US);
+  }
+  printf("}%s\n", last ? "" : ",");
+}
+
+void print_json_string(const char *s) {
+  putchar('"');
+  for (; *s; s++) {
+    const unsigned char c = *s;
+    if (c == '"' || c == '\\') {
+      printf("\\%c", c);
+    } else if (c < 0x20) {
+      printf("\\u%04x", c);
+    } else {
+      putchar(c);
+    }
+  }
+  putchar('"');
+}
+
+void print_summary(const char *const path, const Format format,
+                   const Stats &s) {
+  printf("{\n");
+  printf("  \"file\": ");
+  print_json_string(path);
+  printf(",\n");
+  printf("  \"format\": \"%s\",\n", format == Format::HEX ? "hex" : "bin");
+  printf("  \"unit\": \"us\",\n");
+  printf("  \"records\": %llu,\n", (unsigned long long)s.records);
+  printf("  \"malformed\": %llu,\n", (unsigned long long)s.malformed);
+  printf("  \"sequence\": {\"gaps\": %llu, \"missing\": %llu, "
+         "\"duplicates\": %llu},\n",
+         (unsigned long long)s.gaps, (unsigned long long)s.missing,
+         (unsigned long long)s.duplicates);
+  print_distribution("latency", s.latency_hist, false);
+  print_distribution("interval", s.interval_hist, false);
+  printf("  \"inputs\": [\n");
+  for (int i = 0; i < NUM_INPUTS; i++) {
+    printf("    {\"name\": \"%s\", \"presses\": %llu, \"bounces\": %llu}%s\n",
+           INPUT_NAMES[i], (unsigned long long)s.presses[i],
+           (unsigned long long)s.bounces[i], i + 1 < NUM_INPUTS ? "," : "");
+  }
+  printf("  ]\n");
+  printf("}\n");
+}
+
+// Debug output may interleave some text, so only require mostly hex digits.
+Format guess_format(const uint8_t *const data, const size_t size) {
+  const size_t n = std::min<size_t>(size, 4096);
+  size_t hex = 0;
+  for (size_t i = 0; i < n; i++) {
+    hex += isxdigit(data[i]) || isspace(data[i]);
+  }
+  return hex * 20 >= n * 19 ? Format::HEX : Format::BIN;
+}
+
+// Split at line (hex) or record (bin) boundaries.
+std::vector<size_t> split(const uint8_t *const data, const size_t size,
+                          const Format format, const unsigned n) {
+  std::vector<size_t> bounds{0};
+  for (unsigned i = 1; i < n; i++) {
+    size_t b = size / n * i;
+    if (format == Format::BIN) {
+      b -= b % RECORD_SIZE;
+    } else {
+      const void *eol = memchr(data + b, '\n', size - b);
+      b = eol ? static_cast<const uint8_t *>(eol) - data + 1 : size;
+    }
+    bounds.push_back(std::max(b, bounds.back()));
+  }
+  bounds.push_back(size);
+  return bounds;
+}
+
+void usage() {
+  fprintf(stderr,
+          "usage: trace_analyzer [-f hex|bin] [-j threads] [-w bounce_us] "
+          "capture\n");
+  exit(2);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool format_given = false;
+  Format format = Format::HEX;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  uint32_t bounce_us = 5000;
+  int opt;
+  while ((opt = getopt(argc, argv, "f:j:w:")) != -1) {
+    switch (opt) {
+    case 'f':
+      format_given = true;
+      if (strcmp(optarg, "hex") == 0) {
+        format = Format::HEX;
+      } else if (strcmp(optarg, "bin") == 0) {
+        format = Format::BIN;
+      } else {
+        usage();
+      }
+      break;
+    case 'j': {
+      char *end;
+      errno = 0;
+      const long v = strtol(optarg, &end, 10);
+      if (errno || *end || end == optarg || v < 1 || v > 1024) {
+        usage();
+      }
+      threads = v;
+    } break;
+    case 'w': {
+      char *end;
+      errno = 0;
+      const long v = strtol(optarg, &end, 10);
+      if (errno || *end || end == optarg || v < 0 || v > UINT32_MAX) {
+        usage();
+      }
+      bounce_us = v;
+    } break;
+    default:
+      usage();
+    }
+  }
+  if (optind + 1 != argc) {
+    usage();
+  }
+  const char *const path = argv[optind];
+
+  const int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    fprintf(stderr, "trace_analyzer: %s: %s\n", path, strerror(errno));
+    return 2;
+  }
+  const size_t size = st.st_size;
+  const uint8_t *data = nullptr;
+  if (size > 0) {
+    void *m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m == MAP_FAILED) {
+      fprintf(stderr, "trace_analyzer: %s: %s\n", path, strerror(errno));
+      return 2;
+    }
+    madvise(m, size, MADV_SEQUENTIAL);
+    data = static_cast<const uint8_t *>(m);
+  }
+  if (!format_given) {
+    format = guess_format(data, size);
+  }
+
+  const uint32_t bounce_window = bounce_us / TICK_US;
+  threads = std::min<size_t>(threads, std::max<size_t>(1, size >> 20));
+  const std::vector<size_t> bounds = split(data, size, format, threads);
+  std::vector<Chunk> chunks(threads);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < threads; i++) {
+    workers.emplace_back(analyze_chunk, data + bounds[i], data + bounds[i + 1],
+                         format, bounce_window, std::ref(chunks[i]));
+  }
+  for (std::thread &w : workers) {
+    w.join();
+  }
+
+  print_summary(path, format, stitch(chunks, bounce_window));
+
+  if (size > 0) {
+    munmap(const_cast<uint8_t *>(data), size);
+  }
+  close(fd);
+  return 0;
+}